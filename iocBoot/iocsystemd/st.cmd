@@ -27,6 +27,10 @@ dbLoadRecords("db/systemd.db", "P=serval:,R=service:,SERVICE=serval.service")
 ## Example 4: Control apache2 service (uncomment to enable)
 #dbLoadRecords("db/systemd.db", "P=web:,R=server:,SERVICE=apache2.service")
 
+## Publish unit states to a memory-mapped table for local non-EPICS readers
+## (see servalStandAlone/stateReader). Must be called before iocInit.
+#systemdStateTableConfig("/dev/shm/systemdIoc.state")
+
 cd "${TOP}/iocBoot/${IOC}"
 iocInit
 
@@ -0,0 +1,48 @@
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include "systemd_state_reader.h"
+
+int main(int argc, char *argv[])
+{
+    const char *path = argc >= 2 ? argv[1] : SYSTEMD_STATE_TABLE_DEFAULT;
+    systemd_state_table *table = NULL;
+    systemdStateRecord rec;
+
+    int r = systemd_state_table_open(path, &table);
+    if (r < 0) {
+        fprintf(stderr, "Failed to open state table %s: %s\n", path, strerror(-r));
+        return 1;
+    }
+
+    if (argc >= 3) {
+        int idx = systemd_state_table_find(table, argv[2]);
+        if (idx < 0 || systemd_state_table_read(table, (unsigned)idx, &rec) < 0) {
+            fprintf(stderr, "Unit '%s' not published by the IOC\n", argv[2]);
+            systemd_state_table_close(table);
+            return 1;
+        }
+        printf("%s\n", rec.active_state);
+        systemd_state_table_close(table);
+        return 0;
+    }
+
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    uint64_t now_ns = (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+    uint64_t beat = systemd_state_table_heartbeat(table);
+    printf("generation %llu, heartbeat %.1f s ago%s\n",
+           (unsigned long long)systemd_state_table_generation(table),
+           now_ns > beat ? (now_ns - beat) / 1e9 : 0.0,
+           systemd_state_table_closed(table) ? " (closed)" : "");
+    unsigned count = systemd_state_table_count(table);
+    for (unsigned i = 0; i < count; i++) {
+        if (systemd_state_table_read(table, i, &rec) == 0) {
+            printf("%-40s %-14s %s\n", rec.unit, rec.active_state, rec.status);
+        }
+    }
+
+    systemd_state_table_close(table);
+    return 0;
+}
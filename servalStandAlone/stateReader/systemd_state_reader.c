@@ -0,0 +1,131 @@
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "systemd_state_reader.h"
+
+#define READ_RETRIES 1000
+
+struct systemd_state_table {
+    const systemdStateTableHeader *hdr;
+    const systemdStateRecord *records;
+    size_t size;
+};
+
+int systemd_state_table_open(const char *path, systemd_state_table **out)
+{
+    struct stat st;
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -errno;
+    }
+    if (fstat(fd, &st) != 0) {
+        int err = errno;
+        close(fd);
+        return -err;
+    }
+    if ((size_t)st.st_size < sizeof(systemdStateTableHeader)) {
+        close(fd);
+        return -EPROTO;
+    }
+
+    void *addr = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        return -errno;
+    }
+
+    const systemdStateTableHeader *hdr = (const systemdStateTableHeader *)addr;
+    if (__atomic_load_n(&hdr->magic, __ATOMIC_ACQUIRE) != SYSTEMD_STATE_TABLE_MAGIC ||
+        hdr->version != SYSTEMD_STATE_TABLE_VERSION ||
+        hdr->header_size != sizeof(systemdStateTableHeader) ||
+        hdr->record_size != sizeof(systemdStateRecord) ||
+        SYSTEMD_STATE_TABLE_SIZE(hdr->capacity) > (size_t)st.st_size) {
+        munmap(addr, st.st_size);
+        return -EPROTO;
+    }
+
+    systemd_state_table *table = malloc(sizeof(*table));
+    if (!table) {
+        munmap(addr, st.st_size);
+        return -ENOMEM;
+    }
+    table->hdr = hdr;
+    table->records = systemdStateTableRecords((systemdStateTableHeader *)addr);
+    table->size = st.st_size;
+    *out = table;
+    return 0;
+}
+
+void systemd_state_table_close(systemd_state_table *table)
+{
+    if (!table) {
+        return;
+    }
+    munmap((void *)table->hdr, table->size);
+    free(table);
+}
+
+unsigned systemd_state_table_count(const systemd_state_table *table)
+{
+    unsigned count = __atomic_load_n(&table->hdr->count, __ATOMIC_ACQUIRE);
+    return count < table->hdr->capacity ? count : table->hdr->capacity;
+}
+
+uint64_t systemd_state_table_generation(const systemd_state_table *table)
+{
+    return __atomic_load_n(&table->hdr->generation, __ATOMIC_ACQUIRE);
+}
+
+int systemd_state_table_closed(const systemd_state_table *table)
+{
+    return (__atomic_load_n(&table->hdr->flags, __ATOMIC_ACQUIRE) &
+            SYSTEMD_STATE_TABLE_CLOSED) != 0;
+}
+
+uint64_t systemd_state_table_heartbeat(const systemd_state_table *table)
+{
+    return __atomic_load_n(&table->hdr->heartbeat_ns, __ATOMIC_ACQUIRE);
+}
+
+int systemd_state_table_find(const systemd_state_table *table, const char *unit)
+{
+    unsigned count = systemd_state_table_count(table);
+    for (unsigned i = 0; i < count; i++) {
+        /* Unit names are written once, before the slot is counted */
+        if (strncmp(table->records[i].unit, unit, SYSTEMD_STATE_UNIT_LEN) == 0) {
+            return (int)i;
+        }
+    }
+    return -1;
+}
+
+int systemd_state_table_read(const systemd_state_table *table, unsigned index,
+                             systemdStateRecord *out)
+{
+    if (index >= systemd_state_table_count(table)) {
+        return -EINVAL;
+    }
+
+    const systemdStateRecord *rec = &table->records[index];
+    for (int attempt = 0; attempt < READ_RETRIES; attempt++) {
+        uint32_t before = __atomic_load_n(&rec->seq, __ATOMIC_ACQUIRE);
+        if (before & 1) {
+            continue;
+        }
+        memcpy(out, rec, sizeof(*out));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&rec->seq, __ATOMIC_RELAXED) == before) {
+            out->seq = before;
+            out->unit[SYSTEMD_STATE_UNIT_LEN - 1] = '\0';
+            out->active_state[SYSTEMD_STATE_ACTIVE_LEN - 1] = '\0';
+            out->status[SYSTEMD_STATE_STATUS_LEN - 1] = '\0';
+            return 0;
+        }
+    }
+    return -EAGAIN;
+}
@@ -0,0 +1,49 @@
+/* systemd_state_reader.h */
+/* Read-only access to the unit state table published by systemdIoc
+ * (see systemdStateTableConfig in st.cmd).  After open() every call is a
+ * plain memory read: no D-Bus traffic and no system calls.
+ */
+
+#ifndef SYSTEMD_STATE_READER_H
+#define SYSTEMD_STATE_READER_H
+
+#include "systemdStateTable.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct systemd_state_table systemd_state_table;
+
+/* Map the table read-only. Returns 0 on success or a negative errno
+ * (-EPROTO if the file is not a compatible state table). */
+int systemd_state_table_open(const char *path, systemd_state_table **out);
+void systemd_state_table_close(systemd_state_table *table);
+
+/* Number of units currently published. */
+unsigned systemd_state_table_count(const systemd_state_table *table);
+
+/* Counter that changes whenever any unit changes state; cheap to poll. */
+uint64_t systemd_state_table_generation(const systemd_state_table *table);
+
+/* Non-zero once the IOC has exited or replaced the table; reopen the path. */
+int systemd_state_table_closed(const systemd_state_table *table);
+
+/* CLOCK_MONOTONIC time of the IOC's last heartbeat, refreshed every
+ * SYSTEMD_STATE_HEARTBEAT_NS.  A value that stops advancing means the IOC
+ * hung or was killed without closing the table. */
+uint64_t systemd_state_table_heartbeat(const systemd_state_table *table);
+
+/* Slot index of a unit, or -1 if the IOC has not published it. */
+int systemd_state_table_find(const systemd_state_table *table, const char *unit);
+
+/* Consistent copy of one slot. Returns 0, -EINVAL for a bad index or
+ * -EAGAIN if the writer kept the slot busy for every retry. */
+int systemd_state_table_read(const systemd_state_table *table, unsigned index,
+                             systemdStateRecord *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SYSTEMD_STATE_READER_H */
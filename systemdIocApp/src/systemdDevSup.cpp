@@ -1,20 +1,62 @@
 #include <epicsExport.h>
 #include <devSup.h>
 #include <recGbl.h>
+#include <dbScan.h>
+#include <menuScan.h>
 #include <boRecord.h>
+#include <aoRecord.h>
+#include <aiRecord.h>
+#include <biRecord.h>
+#include <mbboRecord.h>
 #include <stringinRecord.h>
+#include <epicsMutex.h>
+#include <epicsTime.h>
 #include <alarm.h>  // For COMM_ALARM and INVALID_ALARM
 #include <systemd/sd-bus.h>
 #include <string>
+#include <map>
 #include <iostream>
 #include <unistd.h>
 #include <errno.h>
 
+#include "systemdStateTable.h"
+#include "systemdPoll.h"
+#include "systemdPsi.h"
+
 // Structure to store device-specific data
 typedef struct {
     char service_name[256];
+    systemdPollUnit* poll;
 } SystemdDevicePrivate;
 
+// Device-specific data for the PSI records, parsed from "@<service> <resource> ..."
+typedef struct {
+    char service_name[256];
+    systemdPsiUnit* psi;
+    int resource;
+    bool full;
+    int avg;
+} SystemdPsiPrivate;
+
+// Map a systemd ActiveState to our simplified status
+static void map_status(const char* active_state, char* val, size_t len) {
+    const char* status = active_state;
+    if (strcmp(active_state, "active") == 0) {
+        status = "running";
+    } else if (strcmp(active_state, "inactive") == 0) {
+        status = "stopped";
+    } else if (strcmp(active_state, "failed") == 0) {
+        status = "stopped";
+    } else if (strcmp(active_state, "activating") == 0) {
+        status = "starting";
+    } else if (strcmp(active_state, "deactivating") == 0) {
+        status = "stopping";
+    }
+    // For any other state, use it as-is
+    strncpy(val, status, len - 1);
+    val[len - 1] = '\0';
+}
+
 static long init_record_bo(void* prec) {
     boRecord *pbo = (boRecord *)prec;
     
@@ -37,6 +79,7 @@ static long init_record_bo(void* prec) {
         strcpy(dpvt->service_name, "unknown.service");
     }
     
+    dpvt->poll = systemdPollFind(dpvt->service_name);
     pbo->dpvt = dpvt;
     pbo->udf = FALSE;
     return 0;
@@ -64,11 +107,26 @@ static long init_record_stringin(void* prec) {
         strcpy(dpvt->service_name, "unknown.service");
     }
     
+    dpvt->poll = systemdPollFind(dpvt->service_name);
     psi->dpvt = dpvt;
     psi->udf = FALSE;
     return 0;
 }
 
+static long get_ioint_info_stringin(int cmd, void* prec, IOSCANPVT* ppvt) {
+    stringinRecord *psi = (stringinRecord *)prec;
+    SystemdDevicePrivate* dpvt = (SystemdDevicePrivate*)psi->dpvt;
+
+    if (!dpvt) {
+        return -1;
+    }
+
+    // cmd 0: record added to I/O Intr scanning, 1: removed
+    systemdPollEnable(dpvt->poll, cmd == 0);
+    *ppvt = systemdPollScan(dpvt->poll);
+    return 0;
+}
+
 static long read_stringin(void* prec) {
     stringinRecord *psi = (stringinRecord *)prec;
     SystemdDevicePrivate* dpvt = (SystemdDevicePrivate*)psi->dpvt;
@@ -79,6 +137,20 @@ static long read_stringin(void* prec) {
     }
     
     const char* service_name = dpvt->service_name;
+
+    // I/O Intr records are processed by the adaptive poller, which has
+    // already fetched the state for us
+    if (psi->scan == menuScanI_O_Intr) {
+        char active_state[SYSTEMD_STATE_ACTIVE_LEN];
+        if (!systemdPollState(dpvt->poll, active_state, sizeof(active_state))) {
+            recGblSetSevr(psi, COMM_ALARM, INVALID_ALARM);
+            systemdStateTablePublish(service_name, "unknown", "unknown");
+            return -1;
+        }
+        map_status(active_state, psi->val, sizeof(psi->val));
+        systemdStateTablePublish(service_name, active_state, psi->val);
+        return 0;
+    }
     
     // Drop privileges to avoid password prompts
     uid_t current_uid = getuid();
@@ -87,6 +159,7 @@ static long read_stringin(void* prec) {
     if (effective_uid != current_uid) {
         if (seteuid(current_uid) != 0) {
             recGblSetSevr(psi, COMM_ALARM, INVALID_ALARM);
+            systemdStateTablePublish(service_name, "unknown", "unknown");
             return -1;
         }
     }
@@ -96,6 +169,7 @@ static long read_stringin(void* prec) {
     int ret = sd_bus_default_system(&bus);
     if (ret < 0) {
         recGblSetSevr(psi, COMM_ALARM, INVALID_ALARM);
+        systemdStateTablePublish(service_name, "unknown", "unknown");
         return -1;
     }
 
@@ -108,6 +182,7 @@ static long read_stringin(void* prec) {
                             &error, &reply, "");
     if (ret < 0) {
         recGblSetSevr(psi, COMM_ALARM, INVALID_ALARM);
+        systemdStateTablePublish(service_name, "unknown", "unknown");
         sd_bus_error_free(&error);
         sd_bus_unref(bus);
         return -1;
@@ -115,6 +190,7 @@ static long read_stringin(void* prec) {
 
     if (!reply) {
         recGblSetSevr(psi, COMM_ALARM, INVALID_ALARM);
+        systemdStateTablePublish(service_name, "unknown", "unknown");
         sd_bus_unref(bus);
         return -1;
     }
@@ -124,6 +200,7 @@ static long read_stringin(void* prec) {
     if (ret < 0) {
         sd_bus_message_unref(reply);
         recGblSetSevr(psi, COMM_ALARM, INVALID_ALARM);
+        systemdStateTablePublish(service_name, "unknown", "unknown");
         sd_bus_unref(bus);
         return -1;
     }
@@ -159,26 +236,8 @@ static long read_stringin(void* prec) {
     // If we found the service in the list, use its state
     if (result != "not-found") {
         // Map the state to our simplified status
-        if (strcmp(result.c_str(), "active") == 0) {
-            strncpy(psi->val, "running", sizeof(psi->val) - 1);
-            psi->val[sizeof(psi->val) - 1] = '\0';
-        } else if (strcmp(result.c_str(), "inactive") == 0) {
-            strncpy(psi->val, "stopped", sizeof(psi->val) - 1);
-            psi->val[sizeof(psi->val) - 1] = '\0';
-        } else if (strcmp(result.c_str(), "failed") == 0) {
-            strncpy(psi->val, "stopped", sizeof(psi->val) - 1);
-            psi->val[sizeof(psi->val) - 1] = '\0';
-        } else if (strcmp(result.c_str(), "activating") == 0) {
-            strncpy(psi->val, "starting", sizeof(psi->val) - 1);
-            psi->val[sizeof(psi->val) - 1] = '\0';
-        } else if (strcmp(result.c_str(), "deactivating") == 0) {
-            strncpy(psi->val, "stopping", sizeof(psi->val) - 1);
-            psi->val[sizeof(psi->val) - 1] = '\0';
-        } else {
-            // For any other state, use it as-is
-            strncpy(psi->val, result.c_str(), sizeof(psi->val) - 1);
-            psi->val[sizeof(psi->val) - 1] = '\0';
-        }
+        map_status(result.c_str(), psi->val, sizeof(psi->val));
+        systemdStateTablePublish(service_name, result.c_str(), psi->val);
         sd_bus_unref(bus);
         return 0;
     }
@@ -194,6 +253,7 @@ static long read_stringin(void* prec) {
         // Service is not loaded or doesn't exist
         strncpy(psi->val, "not-found", sizeof(psi->val) - 1);
         psi->val[sizeof(psi->val) - 1] = '\0';
+        systemdStateTablePublish(service_name, "not-found", psi->val);
         sd_bus_error_free(&fallback_error);
         sd_bus_unref(bus);
         return 0;
@@ -202,6 +262,7 @@ static long read_stringin(void* prec) {
     if (!fallback_reply) {
         strncpy(psi->val, "unknown", sizeof(psi->val) - 1);
         psi->val[sizeof(psi->val) - 1] = '\0';
+        systemdStateTablePublish(service_name, "unknown", psi->val);
         sd_bus_unref(bus);
         return 0;
     }
@@ -213,6 +274,7 @@ static long read_stringin(void* prec) {
     if (ret < 0 || !unit_path) {
         strncpy(psi->val, "unknown", sizeof(psi->val) - 1);
         psi->val[sizeof(psi->val) - 1] = '\0';
+        systemdStateTablePublish(service_name, "unknown", psi->val);
         sd_bus_unref(bus);
         return 0;
     }
@@ -226,6 +288,7 @@ static long read_stringin(void* prec) {
                             "org.freedesktop.systemd1.Unit", "ActiveState");
     if (ret < 0) {
         recGblSetSevr(psi, COMM_ALARM, INVALID_ALARM);
+        systemdStateTablePublish(service_name, "unknown", "unknown");
         sd_bus_error_free(&state_error);
         sd_bus_unref(bus);
         return -1;
@@ -233,41 +296,110 @@ static long read_stringin(void* prec) {
 
     const char* active_state;
     ret = sd_bus_message_read(state_reply, "v", "s", &active_state);
-    sd_bus_message_unref(state_reply);
     sd_bus_error_free(&state_error);
     if (ret < 0 || !active_state) {
         strncpy(psi->val, "unknown", sizeof(psi->val) - 1);
         psi->val[sizeof(psi->val) - 1] = '\0';
+        systemdStateTablePublish(service_name, "unknown", psi->val);
+        sd_bus_message_unref(state_reply);
         sd_bus_unref(bus);
         return 0;
     }
 
     // Map the fallback state to our simplified status
-    if (strcmp(active_state, "active") == 0) {
-        strncpy(psi->val, "running", sizeof(psi->val) - 1);
-        psi->val[sizeof(psi->val) - 1] = '\0';
-    } else if (strcmp(active_state, "inactive") == 0) {
-        strncpy(psi->val, "stopped", sizeof(psi->val) - 1);
-        psi->val[sizeof(psi->val) - 1] = '\0';
-    } else if (strcmp(active_state, "failed") == 0) {
-        strncpy(psi->val, "stopped", sizeof(psi->val) - 1);
-        psi->val[sizeof(psi->val) - 1] = '\0';
-    } else if (strcmp(active_state, "activating") == 0) {
-        strncpy(psi->val, "starting", sizeof(psi->val) - 1);
-        psi->val[sizeof(psi->val) - 1] = '\0';
-    } else if (strcmp(active_state, "deactivating") == 0) {
-        strncpy(psi->val, "stopping", sizeof(psi->val) - 1);
-        psi->val[sizeof(psi->val) - 1] = '\0';
-    } else {
-        // For any other state, use it as-is
-        strncpy(psi->val, active_state, sizeof(psi->val) - 1);
-        psi->val[sizeof(psi->val) - 1] = '\0';
-    }
+    map_status(active_state, psi->val, sizeof(psi->val));
+    systemdStateTablePublish(service_name, active_state, psi->val);
 
+    // active_state points into the reply, release it only after the last use
+    sd_bus_message_unref(state_reply);
     sd_bus_unref(bus);
     return 0;
 }
 
+// Control actions shared by the Start/Stop bo and the Control mbbo
+enum {
+    CONTROL_STOP = 0,
+    CONTROL_START = 1,
+    CONTROL_STANDBY = 2
+};
+
+// Last ThawUnit duration per service in milliseconds, read by ResumeLatency
+static epicsMutexId resumeLock = nullptr;
+static std::map<std::string, double> resumeLatency;
+
+// Read the FreezerState property (running, freezing, frozen, thawing)
+static int get_freezer_state(sd_bus* bus, const char* service_name, std::string& state) {
+    char* unit_path = nullptr;
+    int ret = sd_bus_path_encode("/org/freedesktop/systemd1/unit", service_name, &unit_path);
+    if (ret < 0) {
+        return ret;
+    }
+
+    sd_bus_error error = SD_BUS_ERROR_NULL;
+    char* value = nullptr;
+    ret = sd_bus_get_property_string(bus, "org.freedesktop.systemd1", unit_path,
+                                     "org.freedesktop.systemd1.Unit", "FreezerState",
+                                     &error, &value);
+    free(unit_path);
+    sd_bus_error_free(&error);
+    if (ret < 0) {
+        return ret;
+    }
+    state = value ? value : "";
+    free(value);
+    return 0;
+}
+
+// Start, stop or park a unit. Starting a frozen unit thaws it instead,
+// which resumes the already-running processes without a cold start.
+static int control_unit(sd_bus* bus, const char* service_name, int action,
+                        sd_bus_error* error, sd_bus_message** reply) {
+    if (action == CONTROL_STANDBY) {
+        return sd_bus_call_method(bus,
+                                  "org.freedesktop.systemd1",
+                                  "/org/freedesktop/systemd1",
+                                  "org.freedesktop.systemd1.Manager",
+                                  "FreezeUnit",
+                                  error,
+                                  reply,
+                                  "s",
+                                  service_name);
+    }
+
+    std::string freezer;
+    if (action == CONTROL_START && get_freezer_state(bus, service_name, freezer) >= 0 &&
+        (freezer == "frozen" || freezer == "freezing")) {
+        // systemd replies to ThawUnit once the cgroup is running again
+        epicsUInt64 t0 = epicsMonotonicGet();
+        int ret = sd_bus_call_method(bus,
+                                     "org.freedesktop.systemd1",
+                                     "/org/freedesktop/systemd1",
+                                     "org.freedesktop.systemd1.Manager",
+                                     "ThawUnit",
+                                     error,
+                                     reply,
+                                     "s",
+                                     service_name);
+        if (ret >= 0 && resumeLock) {
+            epicsMutexLock(resumeLock);
+            resumeLatency[service_name] = (epicsMonotonicGet() - t0) / 1e6;
+            epicsMutexUnlock(resumeLock);
+        }
+        return ret;
+    }
+
+    return sd_bus_call_method(bus,
+                              "org.freedesktop.systemd1",
+                              "/org/freedesktop/systemd1",
+                              "org.freedesktop.systemd1.Manager",
+                              action == CONTROL_START ? "StartUnit" : "StopUnit",
+                              error,
+                              reply,
+                              "ss",
+                              service_name,
+                              "replace");
+}
+
 static long write_bo(void* prec) {
     boRecord *pbo = (boRecord *)prec;
     SystemdDevicePrivate* dpvt = (SystemdDevicePrivate*)pbo->dpvt;
@@ -315,17 +447,8 @@ static long write_bo(void* prec) {
                                service_name);
     } else {
         // This is the Start/Stop record - perform StartUnit or StopUnit action
-        const char* action = pbo->val ? "StartUnit" : "StopUnit";
-        ret = sd_bus_call_method(bus,
-                               "org.freedesktop.systemd1",
-                               "/org/freedesktop/systemd1",
-                               "org.freedesktop.systemd1.Manager",
-                               action,
-                               &error,
-                               &reply,
-                               "ss",
-                               service_name,
-                               "replace");
+        ret = control_unit(bus, service_name, pbo->val ? CONTROL_START : CONTROL_STOP,
+                           &error, &reply);
     }
 
     if (ret < 0) {
@@ -337,6 +460,425 @@ static long write_bo(void* prec) {
 
     sd_bus_message_unref(reply);
     sd_bus_unref(bus);
+
+    // Poll fast while the unit reacts to the command
+    systemdPollKick(dpvt->poll);
+    return 0;
+}
+
+static long init_record_mbbo(void* prec) {
+    mbboRecord *pmbbo = (mbboRecord *)prec;
+
+    // Allocate private data structure
+    SystemdDevicePrivate* dpvt = (SystemdDevicePrivate*)malloc(sizeof(SystemdDevicePrivate));
+    if (!dpvt) {
+        return -1;
+    }
+
+    // Parse the OUT link to get service name
+    if (pmbbo->out.type == INST_IO) {
+        const char* parm = pmbbo->out.value.instio.string;
+        if (parm && strlen(parm) > 0) {
+            strncpy(dpvt->service_name, parm, sizeof(dpvt->service_name) - 1);
+            dpvt->service_name[sizeof(dpvt->service_name) - 1] = '\0';
+        } else {
+            strcpy(dpvt->service_name, "unknown.service");
+        }
+    } else {
+        strcpy(dpvt->service_name, "unknown.service");
+    }
+
+    if (!resumeLock) {
+        resumeLock = epicsMutexMustCreate();
+    }
+    dpvt->poll = systemdPollFind(dpvt->service_name);
+    pmbbo->dpvt = dpvt;
+    pmbbo->udf = FALSE;
+    // Keep VAL from the database, there is no raw value to convert
+    return 2;
+}
+
+static long write_mbbo(void* prec) {
+    mbboRecord *pmbbo = (mbboRecord *)prec;
+    SystemdDevicePrivate* dpvt = (SystemdDevicePrivate*)pmbbo->dpvt;
+
+    if (!dpvt || pmbbo->val > CONTROL_STANDBY) {
+        recGblSetSevr(pmbbo, WRITE_ALARM, INVALID_ALARM);
+        return -1;
+    }
+
+    // Drop privileges to avoid password prompts
+    uid_t current_uid = getuid();
+    uid_t effective_uid = geteuid();
+
+    if (effective_uid != current_uid) {
+        if (seteuid(current_uid) != 0) {
+            recGblSetSevr(pmbbo, COMM_ALARM, INVALID_ALARM);
+            return -1;
+        }
+    }
+
+    sd_bus* bus = nullptr;
+    // Connect to system bus for systemd services
+    int ret = sd_bus_default_system(&bus);
+    if (ret < 0) {
+        recGblSetSevr(pmbbo, COMM_ALARM, INVALID_ALARM);
+        return -1;
+    }
+
+    sd_bus_error error = SD_BUS_ERROR_NULL;
+    sd_bus_message* reply = nullptr;
+
+    ret = control_unit(bus, dpvt->service_name, pmbbo->val, &error, &reply);
+    if (ret < 0) {
+        recGblSetSevr(pmbbo, COMM_ALARM, INVALID_ALARM);
+        sd_bus_error_free(&error);
+        sd_bus_unref(bus);
+        return -1;
+    }
+
+    sd_bus_message_unref(reply);
+    sd_bus_unref(bus);
+
+    // Poll fast while the unit reacts to the command
+    systemdPollKick(dpvt->poll);
+    return 0;
+}
+
+static long get_ioint_info_stringin_freezer(int cmd, void* prec, IOSCANPVT* ppvt) {
+    stringinRecord *psi = (stringinRecord *)prec;
+    SystemdDevicePrivate* dpvt = (SystemdDevicePrivate*)psi->dpvt;
+
+    if (!dpvt) {
+        return -1;
+    }
+
+    // cmd 0: record added to I/O Intr scanning, 1: removed
+    systemdPollEnableFreezer(dpvt->poll, cmd == 0);
+    *ppvt = systemdPollFreezerScan(dpvt->poll);
+    return 0;
+}
+
+static long read_stringin_freezer(void* prec) {
+    stringinRecord *psi = (stringinRecord *)prec;
+    SystemdDevicePrivate* dpvt = (SystemdDevicePrivate*)psi->dpvt;
+
+    if (!dpvt) {
+        recGblSetSevr(psi, COMM_ALARM, INVALID_ALARM);
+        return -1;
+    }
+
+    // I/O Intr records get FreezerState from the poller's batch
+    if (psi->scan == menuScanI_O_Intr) {
+        if (!systemdPollFreezerState(dpvt->poll, psi->val, sizeof(psi->val))) {
+            recGblSetSevr(psi, COMM_ALARM, INVALID_ALARM);
+            return -1;
+        }
+        return 0;
+    }
+
+    // Drop privileges to avoid password prompts
+    uid_t current_uid = getuid();
+    uid_t effective_uid = geteuid();
+
+    if (effective_uid != current_uid) {
+        if (seteuid(current_uid) != 0) {
+            recGblSetSevr(psi, COMM_ALARM, INVALID_ALARM);
+            return -1;
+        }
+    }
+
+    sd_bus* bus = nullptr;
+    // Connect to system bus for systemd services
+    int ret = sd_bus_default_system(&bus);
+    if (ret < 0) {
+        recGblSetSevr(psi, COMM_ALARM, INVALID_ALARM);
+        return -1;
+    }
+
+    std::string state;
+    ret = get_freezer_state(bus, dpvt->service_name, state);
+    sd_bus_unref(bus);
+    if (ret < 0) {
+        // Unit not loaded or systemd without freezer support
+        strncpy(psi->val, "unknown", sizeof(psi->val) - 1);
+        psi->val[sizeof(psi->val) - 1] = '\0';
+        return 0;
+    }
+
+    strncpy(psi->val, state.c_str(), sizeof(psi->val) - 1);
+    psi->val[sizeof(psi->val) - 1] = '\0';
+    return 0;
+}
+
+static long init_record_ai(void* prec) {
+    aiRecord *pai = (aiRecord *)prec;
+
+    // Allocate private data structure
+    SystemdDevicePrivate* dpvt = (SystemdDevicePrivate*)malloc(sizeof(SystemdDevicePrivate));
+    if (!dpvt) {
+        return -1;
+    }
+
+    // Parse the INP link to get service name
+    if (pai->inp.type == INST_IO) {
+        const char* parm = pai->inp.value.instio.string;
+        if (parm && strlen(parm) > 0) {
+            strncpy(dpvt->service_name, parm, sizeof(dpvt->service_name) - 1);
+            dpvt->service_name[sizeof(dpvt->service_name) - 1] = '\0';
+        } else {
+            strcpy(dpvt->service_name, "unknown.service");
+        }
+    } else {
+        strcpy(dpvt->service_name, "unknown.service");
+    }
+
+    if (!resumeLock) {
+        resumeLock = epicsMutexMustCreate();
+    }
+    dpvt->poll = systemdPollFind(dpvt->service_name);
+    pai->dpvt = dpvt;
+    return 0;
+}
+
+static long read_ai_resume_latency(void* prec) {
+    aiRecord *pai = (aiRecord *)prec;
+    SystemdDevicePrivate* dpvt = (SystemdDevicePrivate*)pai->dpvt;
+
+    if (!dpvt) {
+        recGblSetSevr(pai, COMM_ALARM, INVALID_ALARM);
+        return -1;
+    }
+
+    // Leave the record undefined until the first resume has been measured
+    epicsMutexLock(resumeLock);
+    std::map<std::string, double>::iterator it = resumeLatency.find(dpvt->service_name);
+    if (it != resumeLatency.end()) {
+        pai->val = it->second;
+        pai->udf = FALSE;
+    }
+    epicsMutexUnlock(resumeLock);
+
+    // Don't convert, VAL is already in milliseconds
+    return 2;
+}
+
+// Parse "<service> <cpu|memory|io> [some|full avg10|avg60|avg300]"
+static SystemdPsiPrivate* parse_psi_parm(const struct link* plink, bool averages) {
+    if (plink->type != INST_IO || !plink->value.instio.string) {
+        return nullptr;
+    }
+
+    char service[256], resource[16], kind[8] = "some", avg[8] = "avg10";
+    int n = sscanf(plink->value.instio.string, "%255s %15s %7s %7s", service, resource, kind, avg);
+    if (n < 2 || (averages && n < 4)) {
+        return nullptr;
+    }
+
+    SystemdPsiPrivate* dpvt = (SystemdPsiPrivate*)malloc(sizeof(SystemdPsiPrivate));
+    if (!dpvt) {
+        return nullptr;
+    }
+    dpvt->resource = systemdPsiResource(resource);
+    dpvt->full = strcmp(kind, "full") == 0;
+    dpvt->avg = strcmp(avg, "avg60") == 0 ? 60 : strcmp(avg, "avg300") == 0 ? 300 : 10;
+    if (dpvt->resource < 0 || (!dpvt->full && strcmp(kind, "some") != 0)) {
+        free(dpvt);
+        return nullptr;
+    }
+    strncpy(dpvt->service_name, service, sizeof(dpvt->service_name) - 1);
+    dpvt->service_name[sizeof(dpvt->service_name) - 1] = '\0';
+    dpvt->psi = systemdPsiFind(dpvt->service_name);
+    return dpvt;
+}
+
+static long init_record_ai_psi(void* prec) {
+    aiRecord *pai = (aiRecord *)prec;
+
+    SystemdPsiPrivate* dpvt = parse_psi_parm(&pai->inp, true);
+    if (!dpvt) {
+        return -1;
+    }
+    pai->dpvt = dpvt;
+    return 0;
+}
+
+static long read_ai_psi(void* prec) {
+    aiRecord *pai = (aiRecord *)prec;
+    SystemdPsiPrivate* dpvt = (SystemdPsiPrivate*)pai->dpvt;
+
+    if (!dpvt) {
+        recGblSetSevr(pai, COMM_ALARM, INVALID_ALARM);
+        return -1;
+    }
+
+    // Fails while the unit has no cgroup, e.g. when it is stopped
+    double value;
+    if (systemdPsiRead(dpvt->psi, dpvt->resource, dpvt->full, dpvt->avg, &value) < 0) {
+        recGblSetSevr(pai, READ_ALARM, INVALID_ALARM);
+        return -1;
+    }
+
+    pai->val = value;
+    pai->udf = FALSE;
+    // Don't convert, VAL is already in percent
+    return 2;
+}
+
+static long init_record_ao_psi(void* prec) {
+    aoRecord *pao = (aoRecord *)prec;
+
+    SystemdPsiPrivate* dpvt = parse_psi_parm(&pao->out, false);
+    if (!dpvt) {
+        return -1;
+    }
+    pao->dpvt = dpvt;
+    pao->udf = FALSE;
+    // Keep VAL from the database, there is no raw value to convert
+    return 2;
+}
+
+static long write_ao_psi(void* prec) {
+    aoRecord *pao = (aoRecord *)prec;
+    SystemdPsiPrivate* dpvt = (SystemdPsiPrivate*)pao->dpvt;
+
+    // The kernel needs 0 < stall <= window in whole microseconds
+    double stall_us = pao->val * 1000.0;
+    if (!dpvt || stall_us < 0 || (stall_us > 0 && stall_us < 1) ||
+        stall_us > SYSTEMD_PSI_WINDOW_US) {
+        recGblSetSevr(pao, WRITE_ALARM, INVALID_ALARM);
+        return -1;
+    }
+
+    systemdPsiSetTrigger(dpvt->psi, dpvt->resource, pao->val);
+    return 0;
+}
+
+static long init_record_bi_psi(void* prec) {
+    biRecord *pbi = (biRecord *)prec;
+
+    SystemdPsiPrivate* dpvt = parse_psi_parm(&pbi->inp, false);
+    if (!dpvt) {
+        return -1;
+    }
+    pbi->dpvt = dpvt;
+    return 0;
+}
+
+static long get_ioint_info_bi_psi(int, void* prec, IOSCANPVT* ppvt) {
+    biRecord *pbi = (biRecord *)prec;
+    SystemdPsiPrivate* dpvt = (SystemdPsiPrivate*)pbi->dpvt;
+
+    if (!dpvt) {
+        return -1;
+    }
+
+    *ppvt = systemdPsiScan(dpvt->psi, dpvt->resource);
+    return 0;
+}
+
+static long read_bi_psi(void* prec) {
+    biRecord *pbi = (biRecord *)prec;
+    SystemdPsiPrivate* dpvt = (SystemdPsiPrivate*)pbi->dpvt;
+
+    if (!dpvt) {
+        recGblSetSevr(pbi, COMM_ALARM, INVALID_ALARM);
+        return -1;
+    }
+
+    // A threshold without a registered trigger can't report stalls
+    if (systemdPsiUnarmed(dpvt->psi, dpvt->resource)) {
+        recGblSetSevr(pbi, READ_ALARM, INVALID_ALARM);
+    }
+
+    pbi->val = systemdPsiStalled(dpvt->psi, dpvt->resource) ? 1 : 0;
+    pbi->udf = FALSE;
+    // Don't convert, VAL set directly
+    return 2;
+}
+
+static long init_record_ao(void* prec) {
+    aoRecord *pao = (aoRecord *)prec;
+
+    // Allocate private data structure
+    SystemdDevicePrivate* dpvt = (SystemdDevicePrivate*)malloc(sizeof(SystemdDevicePrivate));
+    if (!dpvt) {
+        return -1;
+    }
+
+    // Parse the OUT link to get service name
+    if (pao->out.type == INST_IO) {
+        const char* parm = pao->out.value.instio.string;
+        if (parm && strlen(parm) > 0) {
+            strncpy(dpvt->service_name, parm, sizeof(dpvt->service_name) - 1);
+            dpvt->service_name[sizeof(dpvt->service_name) - 1] = '\0';
+        } else {
+            strcpy(dpvt->service_name, "unknown.service");
+        }
+    } else {
+        strcpy(dpvt->service_name, "unknown.service");
+    }
+
+    dpvt->poll = systemdPollFind(dpvt->service_name);
+    pao->dpvt = dpvt;
+    pao->udf = FALSE;
+    // Keep VAL from the database, there is no raw value to convert
+    return 2;
+}
+
+// Seed the poller with the database value so that the PINI writes of
+// PollMin and PollMax are checked against each other, whichever runs first
+static long init_record_ao_poll_min(void* prec) {
+    aoRecord *pao = (aoRecord *)prec;
+    long ret = init_record_ao(prec);
+    if (pao->dpvt) {
+        systemdPollSetMinPeriod(((SystemdDevicePrivate*)pao->dpvt)->poll, pao->val);
+    }
+    return ret;
+}
+
+static long init_record_ao_poll_max(void* prec) {
+    aoRecord *pao = (aoRecord *)prec;
+    long ret = init_record_ao(prec);
+    if (pao->dpvt) {
+        systemdPollSetMaxPeriod(((SystemdDevicePrivate*)pao->dpvt)->poll, pao->val);
+    }
+    return ret;
+}
+
+static long write_ao_poll_min(void* prec) {
+    aoRecord *pao = (aoRecord *)prec;
+    SystemdDevicePrivate* dpvt = (SystemdDevicePrivate*)pao->dpvt;
+
+    if (!dpvt) {
+        recGblSetSevr(pao, WRITE_ALARM, INVALID_ALARM);
+        return -1;
+    }
+
+    // Reject a minimum above PollMax and keep showing the period in effect
+    if (!systemdPollSetMinPeriod(dpvt->poll, pao->val)) {
+        pao->val = pao->oval = systemdPollMinPeriod(dpvt->poll);
+        recGblSetSevr(pao, WRITE_ALARM, INVALID_ALARM);
+        return -1;
+    }
+    return 0;
+}
+
+static long write_ao_poll_max(void* prec) {
+    aoRecord *pao = (aoRecord *)prec;
+    SystemdDevicePrivate* dpvt = (SystemdDevicePrivate*)pao->dpvt;
+
+    if (!dpvt) {
+        recGblSetSevr(pao, WRITE_ALARM, INVALID_ALARM);
+        return -1;
+    }
+
+    // Reject a maximum below PollMin and keep showing the period in effect
+    if (!systemdPollSetMaxPeriod(dpvt->poll, pao->val)) {
+        pao->val = pao->oval = systemdPollMaxPeriod(dpvt->poll);
+        recGblSetSevr(pao, WRITE_ALARM, INVALID_ALARM);
+        return -1;
+    }
     return 0;
 }
 
@@ -384,10 +926,156 @@ struct {
     NULL,
     NULL,
     init_record_stringin,
-    NULL,
+    (DEVSUPFUN)get_ioint_info_stringin,
     read_stringin
 };
 
+struct {
+    long number;
+    DEVSUPFUN report;
+    DEVSUPFUN init;
+    DEVSUPFUN init_record;
+    DEVSUPFUN get_ioint_info;
+    DEVSUPFUN write_mbbo;
+} devMbboSystemd = {
+    5,
+    NULL,
+    NULL,
+    init_record_mbbo,
+    NULL,
+    write_mbbo
+};
+
+struct {
+    long number;
+    DEVSUPFUN report;
+    DEVSUPFUN init;
+    DEVSUPFUN init_record;
+    DEVSUPFUN get_ioint_info;
+    DEVSUPFUN read_stringin;
+} devStringinSystemdFreezer = {
+    5,
+    NULL,
+    NULL,
+    init_record_stringin,
+    (DEVSUPFUN)get_ioint_info_stringin_freezer,
+    read_stringin_freezer
+};
+
+struct {
+    long number;
+    DEVSUPFUN report;
+    DEVSUPFUN init;
+    DEVSUPFUN init_record;
+    DEVSUPFUN get_ioint_info;
+    DEVSUPFUN read_ai;
+    DEVSUPFUN special_linconv;
+} devAiSystemdResumeLatency = {
+    6,
+    NULL,
+    NULL,
+    init_record_ai,
+    NULL,
+    read_ai_resume_latency,
+    NULL
+};
+
+struct {
+    long number;
+    DEVSUPFUN report;
+    DEVSUPFUN init;
+    DEVSUPFUN init_record;
+    DEVSUPFUN get_ioint_info;
+    DEVSUPFUN write_ao;
+    DEVSUPFUN special_linconv;
+} devAoSystemdPollMin = {
+    6,
+    NULL,
+    NULL,
+    init_record_ao_poll_min,
+    NULL,
+    write_ao_poll_min,
+    NULL
+};
+
+struct {
+    long number;
+    DEVSUPFUN report;
+    DEVSUPFUN init;
+    DEVSUPFUN init_record;
+    DEVSUPFUN get_ioint_info;
+    DEVSUPFUN write_ao;
+    DEVSUPFUN special_linconv;
+} devAoSystemdPollMax = {
+    6,
+    NULL,
+    NULL,
+    init_record_ao_poll_max,
+    NULL,
+    write_ao_poll_max,
+    NULL
+};
+
+struct {
+    long number;
+    DEVSUPFUN report;
+    DEVSUPFUN init;
+    DEVSUPFUN init_record;
+    DEVSUPFUN get_ioint_info;
+    DEVSUPFUN read_ai;
+    DEVSUPFUN special_linconv;
+} devAiSystemdPsi = {
+    6,
+    NULL,
+    NULL,
+    init_record_ai_psi,
+    NULL,
+    read_ai_psi,
+    NULL
+};
+
+struct {
+    long number;
+    DEVSUPFUN report;
+    DEVSUPFUN init;
+    DEVSUPFUN init_record;
+    DEVSUPFUN get_ioint_info;
+    DEVSUPFUN write_ao;
+    DEVSUPFUN special_linconv;
+} devAoSystemdPsiTrigger = {
+    6,
+    NULL,
+    NULL,
+    init_record_ao_psi,
+    NULL,
+    write_ao_psi,
+    NULL
+};
+
+struct {
+    long number;
+    DEVSUPFUN report;
+    DEVSUPFUN init;
+    DEVSUPFUN init_record;
+    DEVSUPFUN get_ioint_info;
+    DEVSUPFUN read_bi;
+} devBiSystemdPsiStall = {
+    5,
+    NULL,
+    NULL,
+    init_record_bi_psi,
+    (DEVSUPFUN)get_ioint_info_bi_psi,
+    read_bi_psi
+};
+
 epicsExportAddress(dset, devBoSystemd);
 epicsExportAddress(dset, devBoSystemdReset);
 epicsExportAddress(dset, devStringinSystemd);
+epicsExportAddress(dset, devMbboSystemd);
+epicsExportAddress(dset, devStringinSystemdFreezer);
+epicsExportAddress(dset, devAiSystemdResumeLatency);
+epicsExportAddress(dset, devAoSystemdPollMin);
+epicsExportAddress(dset, devAoSystemdPollMax);
+epicsExportAddress(dset, devAiSystemdPsi);
+epicsExportAddress(dset, devAoSystemdPsiTrigger);
+epicsExportAddress(dset, devBiSystemdPsiStall);
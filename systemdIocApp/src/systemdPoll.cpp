@@ -0,0 +1,440 @@
+#include <epicsMutex.h>
+#include <epicsEvent.h>
+#include <epicsThread.h>
+#include <epicsTime.h>
+#include <dbScan.h>
+#include <errlog.h>
+#include <systemd/sd-bus.h>
+#include <map>
+#include <string>
+#include <vector>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "systemdPoll.h"
+
+// Units due within this window are folded into the current batch
+#define BATCH_SLACK_NS  50000000ull
+// Polls kept at the minimum period after a command, before backing off
+#define KICK_FAST_POLLS 5
+
+typedef std::multimap<epicsUInt64, systemdPollUnit*> TimerQueue;
+
+struct systemdPollUnit {
+    std::string name;
+    IOSCANPVT scan;
+    int users;                  // I/O Intr records using this unit
+    int freezerUsers;           // ... of which want FreezerState
+    double minPeriod;
+    double maxPeriod;
+    double period;
+    int fastPolls;
+    bool queued;
+    TimerQueue::iterator due;
+    bool valid;                 // last poll succeeded
+    std::string state;          // last polled ActiveState
+    IOSCANPVT freezerScan;
+    std::string freezer;        // last polled FreezerState
+};
+
+struct PolledUnit {
+    std::string state;
+    std::string path;
+};
+
+static epicsThreadOnceId pollOnce = EPICS_THREAD_ONCE_INIT;
+static epicsMutexId pollLock;
+static epicsEventId pollWake;
+static bool pollThreadStarted = false;
+static std::map<std::string, systemdPollUnit*> pollUnits;
+static TimerQueue timerQueue;
+
+static void poll_once(void*) {
+    pollLock = epicsMutexMustCreate();
+    pollWake = epicsEventMustCreate(epicsEventEmpty);
+}
+
+static epicsUInt64 seconds_to_ns(double seconds) {
+    return (epicsUInt64)(seconds * 1e9);
+}
+
+// Caller holds pollLock
+static void schedule(systemdPollUnit* u, epicsUInt64 when) {
+    if (u->queued) {
+        timerQueue.erase(u->due);
+    }
+    u->due = timerQueue.insert(std::make_pair(when, u));
+    u->queued = true;
+}
+
+static bool is_transitional(const std::string& state) {
+    return state == "activating" || state == "deactivating" ||
+           state == "reloading" || state == "refreshing" ||
+           state == "freezing" || state == "thawing";
+}
+
+// Fetch ActiveState and object path for all names with a single
+// ListUnitsByNames call. Units unknown to systemd come back with LoadState
+// "not-found".
+static int fetch_states(sd_bus* bus, const std::vector<std::string>& names,
+                        std::map<std::string, PolledUnit>& states) {
+    sd_bus_message* msg = nullptr;
+    sd_bus_message* reply = nullptr;
+    sd_bus_error error = SD_BUS_ERROR_NULL;
+
+    int ret = sd_bus_message_new_method_call(bus, &msg, "org.freedesktop.systemd1",
+                                             "/org/freedesktop/systemd1",
+                                             "org.freedesktop.systemd1.Manager",
+                                             "ListUnitsByNames");
+    if (ret < 0) {
+        return ret;
+    }
+    ret = sd_bus_message_open_container(msg, 'a', "s");
+    for (size_t i = 0; ret >= 0 && i < names.size(); i++) {
+        ret = sd_bus_message_append(msg, "s", names[i].c_str());
+    }
+    if (ret >= 0) {
+        ret = sd_bus_message_close_container(msg);
+    }
+    if (ret >= 0) {
+        ret = sd_bus_call(bus, msg, 0, &error, &reply);
+    }
+    sd_bus_message_unref(msg);
+    if (ret < 0) {
+        sd_bus_error_free(&error);
+        return ret;
+    }
+
+    ret = sd_bus_message_enter_container(reply, 'a', "(ssssssouso)");
+    if (ret < 0) {
+        sd_bus_message_unref(reply);
+        return ret;
+    }
+
+    while ((ret = sd_bus_message_enter_container(reply, 'r', "ssssssouso")) > 0) {
+        const char *name = nullptr, *description = nullptr, *load_state = nullptr,
+                   *active_state = nullptr, *sub_state = nullptr, *following = nullptr,
+                   *unit_path = nullptr, *job_type = nullptr, *job_path = nullptr;
+        uint32_t job_id = 0;
+
+        ret = sd_bus_message_read(reply, "ssssssouso", &name, &description, &load_state,
+                                 &active_state, &sub_state, &following, &unit_path,
+                                 &job_id, &job_type, &job_path);
+        sd_bus_message_exit_container(reply);
+        if (ret < 0) {
+            break;
+        }
+        if (name && active_state) {
+            PolledUnit& polled = states[name];
+            if (load_state && strcmp(load_state, "not-found") == 0) {
+                polled.state = "not-found";
+            } else {
+                polled.state = active_state;
+                polled.path = unit_path ? unit_path : "";
+            }
+        }
+    }
+
+    sd_bus_message_exit_container(reply);
+    sd_bus_message_unref(reply);
+    return ret < 0 ? ret : 0;
+}
+
+// FreezerState of a loaded unit. Only units with processes can be frozen,
+// so stopped units are reported as running without asking systemd.
+static std::string fetch_freezer(sd_bus* bus, const PolledUnit* polled) {
+    if (!polled || polled->state == "not-found") {
+        return "unknown";
+    }
+    if (polled->state == "inactive" || polled->state == "failed" || polled->path.empty()) {
+        return "running";
+    }
+
+    sd_bus_error error = SD_BUS_ERROR_NULL;
+    char* value = nullptr;
+    int ret = sd_bus_get_property_string(bus, "org.freedesktop.systemd1", polled->path.c_str(),
+                                         "org.freedesktop.systemd1.Unit", "FreezerState",
+                                         &error, &value);
+    sd_bus_error_free(&error);
+    // systemd without freezer support has no such property
+    std::string freezer = ret >= 0 && value ? value : "unknown";
+    free(value);
+    return freezer;
+}
+
+static void poll_thread(void*) {
+    sd_bus* bus = nullptr;
+    std::vector<systemdPollUnit*> batch;
+    std::vector<std::string> names;
+    std::vector<bool> wantFreezer;
+    std::vector<std::string> freezers;
+    std::map<std::string, PolledUnit> states;
+
+    // Drop privileges to avoid password prompts, as the record threads do
+    uid_t current_uid = getuid();
+    if (geteuid() != current_uid && seteuid(current_uid) != 0) {
+        errlogPrintf("systemdPoll: failed to drop privileges\n");
+    }
+
+    while (true) {
+        epicsMutexLock(pollLock);
+        epicsUInt64 now = epicsMonotonicGet();
+        batch.clear();
+        names.clear();
+        wantFreezer.clear();
+        while (!timerQueue.empty() && timerQueue.begin()->first <= now + BATCH_SLACK_NS) {
+            systemdPollUnit* u = timerQueue.begin()->second;
+            timerQueue.erase(timerQueue.begin());
+            u->queued = false;
+            if (u->users > 0) {
+                batch.push_back(u);
+                names.push_back(u->name);
+                wantFreezer.push_back(u->freezerUsers > 0);
+            }
+        }
+        double wait = -1.0;
+        if (batch.empty() && !timerQueue.empty()) {
+            wait = (timerQueue.begin()->first - now) / 1e9;
+        }
+        epicsMutexUnlock(pollLock);
+
+        if (batch.empty()) {
+            if (wait < 0) {
+                epicsEventMustWait(pollWake);
+            } else {
+                epicsEventWaitWithTimeout(pollWake, wait);
+            }
+            continue;
+        }
+
+        states.clear();
+        int ret = bus ? 0 : sd_bus_default_system(&bus);
+        if (ret >= 0) {
+            ret = fetch_states(bus, names, states);
+        }
+        // FreezerState is not part of ListUnitsByNames, fetch it per unit and
+        // only for units whose FreezerState records are I/O Intr
+        freezers.assign(batch.size(), std::string());
+        for (size_t i = 0; ret >= 0 && i < batch.size(); i++) {
+            if (wantFreezer[i]) {
+                std::map<std::string, PolledUnit>::iterator it = states.find(names[i]);
+                freezers[i] = fetch_freezer(bus, it != states.end() ? &it->second : nullptr);
+            }
+        }
+        if (ret < 0 && bus) {
+            // Reconnect on the next batch in case the bus went away
+            sd_bus_unref(bus);
+            bus = nullptr;
+        }
+
+        epicsMutexLock(pollLock);
+        now = epicsMonotonicGet();
+        for (size_t i = 0; i < batch.size(); i++) {
+            systemdPollUnit* u = batch[i];
+            if (ret < 0) {
+                u->valid = false;
+            } else {
+                std::map<std::string, PolledUnit>::iterator it = states.find(u->name);
+                std::string state = it != states.end() ? it->second.state : "not-found";
+                bool changed = !u->valid || state != u->state;
+                u->valid = true;
+                u->state = state;
+                if (wantFreezer[i]) {
+                    changed = changed || freezers[i] != u->freezer;
+                    u->freezer = freezers[i];
+                }
+                if (changed || is_transitional(state) || is_transitional(u->freezer) ||
+                    u->fastPolls > 0) {
+                    u->period = u->minPeriod;
+                    if (u->fastPolls > 0) {
+                        u->fastPolls--;
+                    }
+                } else {
+                    u->period *= 2;
+                }
+            }
+            if (u->period > u->maxPeriod) {
+                u->period = u->maxPeriod;
+            }
+            if (u->period < u->minPeriod) {
+                u->period = u->minPeriod;
+            }
+            // A kick or a new record may already have rescheduled the unit
+            if (!u->queued) {
+                schedule(u, now + seconds_to_ns(u->period));
+            }
+        }
+        epicsMutexUnlock(pollLock);
+
+        for (size_t i = 0; i < batch.size(); i++) {
+            scanIoRequest(batch[i]->scan);
+            if (wantFreezer[i]) {
+                scanIoRequest(batch[i]->freezerScan);
+            }
+        }
+    }
+}
+
+systemdPollUnit* systemdPollFind(const char* unit) {
+    epicsThreadOnce(&pollOnce, poll_once, nullptr);
+
+    epicsMutexLock(pollLock);
+    std::map<std::string, systemdPollUnit*>::iterator it = pollUnits.find(unit);
+    systemdPollUnit* u;
+    if (it != pollUnits.end()) {
+        u = it->second;
+    } else {
+        u = new systemdPollUnit();
+        u->name = unit;
+        scanIoInit(&u->scan);
+        scanIoInit(&u->freezerScan);
+        u->users = 0;
+        u->freezerUsers = 0;
+        u->minPeriod = SYSTEMD_POLL_MIN_PERIOD;
+        u->maxPeriod = SYSTEMD_POLL_MAX_PERIOD;
+        u->period = SYSTEMD_POLL_MIN_PERIOD;
+        u->fastPolls = 0;
+        u->queued = false;
+        u->valid = false;
+        pollUnits[unit] = u;
+    }
+    epicsMutexUnlock(pollLock);
+    return u;
+}
+
+IOSCANPVT systemdPollScan(systemdPollUnit* unit) {
+    return unit->scan;
+}
+
+// Caller holds pollLock
+static void enable_unit(systemdPollUnit* unit, bool enable) {
+    if (enable) {
+        if (unit->users++ == 0) {
+            unit->period = unit->minPeriod;
+            schedule(unit, epicsMonotonicGet());
+        }
+        if (!pollThreadStarted) {
+            epicsThreadCreate("systemdPoll", epicsThreadPriorityMedium,
+                              epicsThreadGetStackSize(epicsThreadStackMedium),
+                              poll_thread, nullptr);
+            pollThreadStarted = true;
+        }
+    } else if (unit->users > 0 && --unit->users == 0 && unit->queued) {
+        timerQueue.erase(unit->due);
+        unit->queued = false;
+    }
+}
+
+void systemdPollEnable(systemdPollUnit* unit, bool enable) {
+    epicsMutexLock(pollLock);
+    enable_unit(unit, enable);
+    epicsMutexUnlock(pollLock);
+    epicsEventSignal(pollWake);
+}
+
+void systemdPollEnableFreezer(systemdPollUnit* unit, bool enable) {
+    epicsMutexLock(pollLock);
+    if (enable) {
+        unit->freezerUsers++;
+        // Poll now rather than wait out the back-off to fill the new cache
+        if (unit->users > 0) {
+            unit->period = unit->minPeriod;
+            schedule(unit, epicsMonotonicGet());
+        }
+    } else if (unit->freezerUsers > 0) {
+        unit->freezerUsers--;
+    }
+    enable_unit(unit, enable);
+    epicsMutexUnlock(pollLock);
+    epicsEventSignal(pollWake);
+}
+
+IOSCANPVT systemdPollFreezerScan(systemdPollUnit* unit) {
+    return unit->freezerScan;
+}
+
+bool systemdPollState(systemdPollUnit* unit, char* buf, size_t len) {
+    epicsMutexLock(pollLock);
+    bool valid = unit->valid;
+    if (valid) {
+        strncpy(buf, unit->state.c_str(), len - 1);
+        buf[len - 1] = '\0';
+    }
+    epicsMutexUnlock(pollLock);
+    return valid;
+}
+
+bool systemdPollFreezerState(systemdPollUnit* unit, char* buf, size_t len) {
+    epicsMutexLock(pollLock);
+    bool valid = unit->valid && !unit->freezer.empty();
+    if (valid) {
+        strncpy(buf, unit->freezer.c_str(), len - 1);
+        buf[len - 1] = '\0';
+    }
+    epicsMutexUnlock(pollLock);
+    return valid;
+}
+
+void systemdPollKick(systemdPollUnit* unit) {
+    epicsMutexLock(pollLock);
+    unit->period = unit->minPeriod;
+    unit->fastPolls = KICK_FAST_POLLS;
+    if (unit->users > 0) {
+        schedule(unit, epicsMonotonicGet());
+    }
+    epicsMutexUnlock(pollLock);
+    epicsEventSignal(pollWake);
+}
+
+// Caller holds pollLock. Pull the next poll forward if the new period is shorter.
+static void apply_periods(systemdPollUnit* u) {
+    if (u->period < u->minPeriod) {
+        u->period = u->minPeriod;
+    }
+    if (u->period > u->maxPeriod) {
+        u->period = u->maxPeriod;
+    }
+    epicsUInt64 when = epicsMonotonicGet() + seconds_to_ns(u->period);
+    if (u->queued && u->due->first > when) {
+        schedule(u, when);
+    }
+}
+
+bool systemdPollSetMinPeriod(systemdPollUnit* unit, double seconds) {
+    epicsMutexLock(pollLock);
+    bool ok = seconds > 0 && seconds <= unit->maxPeriod;
+    if (ok) {
+        unit->minPeriod = seconds;
+        apply_periods(unit);
+    }
+    epicsMutexUnlock(pollLock);
+    epicsEventSignal(pollWake);
+    return ok;
+}
+
+bool systemdPollSetMaxPeriod(systemdPollUnit* unit, double seconds) {
+    epicsMutexLock(pollLock);
+    bool ok = seconds > 0 && seconds >= unit->minPeriod;
+    if (ok) {
+        unit->maxPeriod = seconds;
+        apply_periods(unit);
+    }
+    epicsMutexUnlock(pollLock);
+    epicsEventSignal(pollWake);
+    return ok;
+}
+
+double systemdPollMinPeriod(systemdPollUnit* unit) {
+    epicsMutexLock(pollLock);
+    double seconds = unit->minPeriod;
+    epicsMutexUnlock(pollLock);
+    return seconds;
+}
+
+double systemdPollMaxPeriod(systemdPollUnit* unit) {
+    epicsMutexLock(pollLock);
+    double seconds = unit->maxPeriod;
+    epicsMutexUnlock(pollLock);
+    return seconds;
+}
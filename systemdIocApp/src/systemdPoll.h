@@ -0,0 +1,51 @@
+/* systemdPoll.h */
+/* Adaptive ActiveState poller used by Status records with SCAN "I/O Intr".
+ *
+ * A single thread keeps a timer queue of units ordered by their next due
+ * time. Units that are due (or nearly due) are fetched together with one
+ * ListUnitsByNames call and their records are processed via scanIoRequest.
+ * A unit is polled at its minimum period while it is transitioning or
+ * right after a command, and its period doubles up to the maximum period
+ * once the state is stable. Units with I/O Intr FreezerState records also
+ * have FreezerState fetched in the same poll.
+ */
+
+#ifndef SYSTEMD_POLL_H
+#define SYSTEMD_POLL_H
+
+#include <stddef.h>
+#include <dbScan.h>
+
+#define SYSTEMD_POLL_MIN_PERIOD  0.2   /* seconds */
+#define SYSTEMD_POLL_MAX_PERIOD  30.0  /* seconds */
+
+struct systemdPollUnit;
+
+/* Look up a unit, creating it on first use. Never returns NULL. */
+systemdPollUnit* systemdPollFind(const char* unit);
+
+IOSCANPVT systemdPollScan(systemdPollUnit* unit);
+
+/* Start/stop polling the unit as I/O Intr records are added/removed. */
+void systemdPollEnable(systemdPollUnit* unit, bool enable);
+
+/* Copy the last polled ActiveState; false if the last poll failed. */
+bool systemdPollState(systemdPollUnit* unit, char* buf, size_t len);
+
+/* Same for FreezerState records, which are polled on their own scan list. */
+void systemdPollEnableFreezer(systemdPollUnit* unit, bool enable);
+IOSCANPVT systemdPollFreezerScan(systemdPollUnit* unit);
+bool systemdPollFreezerState(systemdPollUnit* unit, char* buf, size_t len);
+
+/* Poll now and restart back-off from the minimum period. */
+void systemdPollKick(systemdPollUnit* unit);
+
+/* Change one period limit. Returns false, leaving both limits unchanged,
+ * if the value is not positive or would put the minimum above the maximum. */
+bool systemdPollSetMinPeriod(systemdPollUnit* unit, double seconds);
+bool systemdPollSetMaxPeriod(systemdPollUnit* unit, double seconds);
+
+double systemdPollMinPeriod(systemdPollUnit* unit);
+double systemdPollMaxPeriod(systemdPollUnit* unit);
+
+#endif /* SYSTEMD_POLL_H */
@@ -0,0 +1,492 @@
+#include <epicsMutex.h>
+#include <epicsEvent.h>
+#include <epicsThread.h>
+#include <epicsTime.h>
+#include <dbScan.h>
+#include <errlog.h>
+#include <systemd/sd-bus.h>
+#include <map>
+#include <string>
+#include <vector>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+#include "systemdPsi.h"
+
+// How often to retry cgroup lookups and trigger registration that failed
+#define RETRY_PERIOD_NS  5000000000ull
+
+static const char* const resourceNames[SYSTEMD_PSI_RESOURCES] = {"cpu", "memory", "io"};
+
+struct PsiTrigger {
+    IOSCANPVT scan;
+    double stallMs;             // 0 when disarmed
+    int fd;                     // trigger fd, owned by the monitor thread
+    bool rearm;                 // threshold changed or fd went away
+    int lastError;              // last registration errno, to log it once
+    bool stalled;
+    epicsUInt64 lastEvent;
+};
+
+struct systemdPsiUnit {
+    std::string name;
+    std::string cgroupDir;      // empty until ControlGroup has been resolved
+    bool resolve;               // look up ControlGroup again
+    bool resolveNow;            // ... without waiting for the retry period
+    PsiTrigger trigger[SYSTEMD_PSI_RESOURCES];
+};
+
+static epicsThreadOnceId psiOnce = EPICS_THREAD_ONCE_INIT;
+static epicsMutexId psiLock;
+static epicsEventId resolveWake;
+static int wakePipe[2] = {-1, -1};
+static std::string cgroupRoot = SYSTEMD_PSI_CGROUP_ROOT;
+static std::map<std::string, systemdPsiUnit*> psiUnits;
+
+static void psi_wake() {
+    char c = 0;
+    if (write(wakePipe[1], &c, 1) < 0) {
+        // Pipe full means a wake-up is already pending
+    }
+}
+
+// D-Bus interface carrying ControlGroup for this unit type
+static const char* unit_interface(const std::string& name) {
+    static const char* const types[][2] = {
+        {".service", "org.freedesktop.systemd1.Service"},
+        {".scope",   "org.freedesktop.systemd1.Scope"},
+        {".slice",   "org.freedesktop.systemd1.Slice"},
+        {".socket",  "org.freedesktop.systemd1.Socket"},
+        {".mount",   "org.freedesktop.systemd1.Mount"},
+        {".swap",    "org.freedesktop.systemd1.Swap"},
+    };
+    for (size_t i = 0; i < sizeof(types) / sizeof(types[0]); i++) {
+        size_t len = strlen(types[i][0]);
+        if (name.size() > len && name.compare(name.size() - len, len, types[i][0]) == 0) {
+            return types[i][1];
+        }
+    }
+    return nullptr;
+}
+
+// Wake the cgroup thread after setting resolve on a unit
+static void resolve_wake() {
+    epicsEventSignal(resolveWake);
+}
+
+// Resolve the unit's cgroup directory; empty if the unit has no cgroup now
+static int resolve_cgroup(sd_bus* bus, const std::string& name, std::string& dir) {
+    const char* iface = unit_interface(name);
+    if (!iface) {
+        return -EINVAL;
+    }
+
+    char* unit_path = nullptr;
+    int ret = sd_bus_path_encode("/org/freedesktop/systemd1/unit", name.c_str(), &unit_path);
+    if (ret < 0) {
+        return ret;
+    }
+
+    sd_bus_error error = SD_BUS_ERROR_NULL;
+    char* cgroup = nullptr;
+    ret = sd_bus_get_property_string(bus, "org.freedesktop.systemd1", unit_path, iface,
+                                     "ControlGroup", &error, &cgroup);
+    free(unit_path);
+    sd_bus_error_free(&error);
+    if (ret < 0) {
+        return ret;
+    }
+
+    dir.clear();
+    if (cgroup && strlen(cgroup) > 0) {
+        dir = cgroupRoot + cgroup;
+    }
+    free(cgroup);
+    return 0;
+}
+
+// Register a PSI trigger. Returns the fd or a negative errno.
+static int arm_trigger(const std::string& dir, int resource, double stall_ms) {
+    std::string path = dir + "/" + resourceNames[resource] + ".pressure";
+    int fd = open(path.c_str(), O_RDWR | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        return -errno;
+    }
+
+    char spec[64];
+    snprintf(spec, sizeof(spec), "some %lld %d",
+             (long long)(stall_ms * 1000.0), SYSTEMD_PSI_WINDOW_US);
+    // The kernel expects the terminating NUL as part of the write
+    if (write(fd, spec, strlen(spec) + 1) < 0) {
+        int err = errno;
+        close(fd);
+        return -err;
+    }
+    return fd;
+}
+
+// ControlGroup lookups are synchronous D-Bus calls that can block for the
+// full D-Bus timeout while systemd is busy, so they run here and not on the
+// monitor thread. Results are handed over under psiLock.
+static void cgroup_thread(void*) {
+    sd_bus* bus = nullptr;
+    std::vector<std::string> lookups;
+    epicsUInt64 nextRetry = 0;
+
+    // Drop privileges to avoid password prompts, as the record threads do
+    uid_t current_uid = getuid();
+    if (geteuid() != current_uid && seteuid(current_uid) != 0) {
+        errlogPrintf("systemdPsi: failed to drop privileges\n");
+    }
+
+    while (true) {
+        epicsUInt64 now = epicsMonotonicGet();
+        bool retryDue = now >= nextRetry;
+
+        lookups.clear();
+        bool pending = false;
+        epicsMutexLock(psiLock);
+        for (std::map<std::string, systemdPsiUnit*>::iterator it = psiUnits.begin();
+             it != psiUnits.end(); ++it) {
+            systemdPsiUnit* u = it->second;
+            if (u->resolve && (retryDue || u->resolveNow)) {
+                lookups.push_back(it->first);
+            }
+            u->resolveNow = false;
+        }
+        epicsMutexUnlock(psiLock);
+
+        for (size_t i = 0; i < lookups.size(); i++) {
+            std::string dir;
+            int ret = bus ? 0 : sd_bus_default_system(&bus);
+            if (ret >= 0) {
+                ret = resolve_cgroup(bus, lookups[i], dir);
+            }
+            if (ret < 0) {
+                if (bus) {
+                    sd_bus_unref(bus);
+                    bus = nullptr;
+                }
+                continue;
+            }
+            epicsMutexLock(psiLock);
+            systemdPsiUnit* u = psiUnits[lookups[i]];
+            u->cgroupDir = dir;
+            u->resolve = dir.empty();
+            for (int r = 0; r < SYSTEMD_PSI_RESOURCES; r++) {
+                u->trigger[r].rearm = true;
+            }
+            epicsMutexUnlock(psiLock);
+        }
+        if (!lookups.empty()) {
+            psi_wake();
+        }
+        if (retryDue) {
+            nextRetry = now + RETRY_PERIOD_NS;
+        }
+
+        epicsMutexLock(psiLock);
+        for (std::map<std::string, systemdPsiUnit*>::iterator it = psiUnits.begin();
+             it != psiUnits.end(); ++it) {
+            pending = pending || it->second->resolve;
+        }
+        epicsMutexUnlock(psiLock);
+
+        now = epicsMonotonicGet();
+        if (!pending) {
+            epicsEventMustWait(resolveWake);
+        } else if (nextRetry > now) {
+            epicsEventWaitWithTimeout(resolveWake, (nextRetry - now) / 1e9);
+        }
+    }
+}
+
+static void psi_thread(void*) {
+    std::vector<struct pollfd> fds;
+    std::vector<std::pair<systemdPsiUnit*, int> > owners;
+    std::vector<IOSCANPVT> requests;
+    epicsUInt64 nextRetry = 0;
+    // The kernel fires at most once per window, so hold the stall flag a bit
+    // longer than that to ride out the gap between consecutive events
+    const epicsUInt64 hold_ns = (epicsUInt64)SYSTEMD_PSI_WINDOW_US * 1500ull;
+
+    // Drop privileges to avoid password prompts, as the record threads do
+    uid_t current_uid = getuid();
+    if (geteuid() != current_uid && seteuid(current_uid) != 0) {
+        errlogPrintf("systemdPsi: failed to drop privileges\n");
+    }
+
+    while (true) {
+        epicsUInt64 now = epicsMonotonicGet();
+        bool retryDue = now >= nextRetry;
+        if (retryDue) {
+            nextRetry = now + RETRY_PERIOD_NS;
+        }
+
+        // (Re)arm triggers and build the poll set
+        fds.clear();
+        owners.clear();
+        requests.clear();
+        struct pollfd wake = {wakePipe[0], POLLIN, 0};
+        fds.push_back(wake);
+        owners.push_back(std::make_pair((systemdPsiUnit*)nullptr, 0));
+
+        bool retry = false;
+        bool lookup = false;
+        epicsUInt64 deadline = now + RETRY_PERIOD_NS;
+        epicsMutexLock(psiLock);
+        for (std::map<std::string, systemdPsiUnit*>::iterator it = psiUnits.begin();
+             it != psiUnits.end(); ++it) {
+            systemdPsiUnit* u = it->second;
+            for (int r = 0; r < SYSTEMD_PSI_RESOURCES; r++) {
+                PsiTrigger* t = &u->trigger[r];
+                // Failed registrations are only retried every RETRY_PERIOD_NS
+                if (t->rearm && (t->lastError == 0 || retryDue)) {
+                    if (t->fd >= 0) {
+                        close(t->fd);
+                        t->fd = -1;
+                    }
+                    t->rearm = false;
+                    if (t->stallMs > 0 && !u->cgroupDir.empty()) {
+                        int fd = arm_trigger(u->cgroupDir, r, t->stallMs);
+                        if (fd < 0) {
+                            if (-fd != t->lastError) {
+                                errlogPrintf("systemdPsi: %s %s trigger: %s\n", u->name.c_str(),
+                                             resourceNames[r], strerror(-fd));
+                            }
+                            t->lastError = -fd;
+                            // The cgroup may be gone, look it up again
+                            if (fd == -ENOENT) {
+                                u->resolve = true;
+                                lookup = true;
+                            }
+                            t->rearm = true;
+                        } else {
+                            t->fd = fd;
+                            t->lastError = 0;
+                        }
+                    } else if (t->stallMs <= 0) {
+                        t->stalled = false;
+                    }
+                    // Let the Stall records show the new armed/disarmed state
+                    requests.push_back(t->scan);
+                }
+                if (t->fd >= 0) {
+                    struct pollfd p = {t->fd, POLLPRI, 0};
+                    fds.push_back(p);
+                    owners.push_back(std::make_pair(u, r));
+                }
+                retry = retry || t->rearm;
+                if (t->stalled && t->lastEvent + hold_ns < deadline) {
+                    deadline = t->lastEvent + hold_ns;
+                }
+            }
+        }
+        epicsMutexUnlock(psiLock);
+
+        if (lookup) {
+            resolve_wake();
+        }
+        for (size_t i = 0; i < requests.size(); i++) {
+            scanIoRequest(requests[i]);
+        }
+        requests.clear();
+
+        // Sleep until an event, a wake-up, a stall flag expiring or a retry
+        int timeout = -1;
+        if (retry || deadline < now + RETRY_PERIOD_NS) {
+            epicsUInt64 until = deadline;
+            if (retry && nextRetry < until) {
+                until = nextRetry;
+            }
+            timeout = until > now ? (int)((until - now + 999999) / 1000000) : 0;
+        }
+        int n = poll(&fds[0], fds.size(), timeout);
+        if (n < 0 && errno != EINTR) {
+            errlogPrintf("systemdPsi: poll failed: %s\n", strerror(errno));
+            epicsThreadSleep(1.0);
+            continue;
+        }
+
+        if (fds[0].revents & POLLIN) {
+            char buf[64];
+            while (read(wakePipe[0], buf, sizeof(buf)) > 0) {
+            }
+        }
+
+        now = epicsMonotonicGet();
+        lookup = false;
+        epicsMutexLock(psiLock);
+        for (size_t i = 1; n > 0 && i < fds.size(); i++) {
+            systemdPsiUnit* u = owners[i].first;
+            PsiTrigger* t = &u->trigger[owners[i].second];
+            if (fds[i].revents & (POLLERR | POLLNVAL)) {
+                // The cgroup was removed, e.g. the unit stopped. Re-arm once
+                // the cgroup thread has found the new one.
+                t->rearm = true;
+                u->cgroupDir.clear();
+                u->resolve = true;
+                u->resolveNow = true;
+                lookup = true;
+            } else if (fds[i].revents & POLLPRI) {
+                t->stalled = true;
+                t->lastEvent = now;
+                requests.push_back(t->scan);
+            }
+        }
+        // Clear stall flags once the hold time passed without an event
+        for (std::map<std::string, systemdPsiUnit*>::iterator it = psiUnits.begin();
+             it != psiUnits.end(); ++it) {
+            for (int r = 0; r < SYSTEMD_PSI_RESOURCES; r++) {
+                PsiTrigger* t = &it->second->trigger[r];
+                if (t->stalled && t->lastEvent + hold_ns <= now) {
+                    t->stalled = false;
+                    requests.push_back(t->scan);
+                }
+            }
+        }
+        epicsMutexUnlock(psiLock);
+
+        if (lookup) {
+            resolve_wake();
+        }
+        for (size_t i = 0; i < requests.size(); i++) {
+            scanIoRequest(requests[i]);
+        }
+    }
+}
+
+static void psi_once(void*) {
+    psiLock = epicsMutexMustCreate();
+    resolveWake = epicsEventMustCreate(epicsEventEmpty);
+    std::string hybrid = std::string(SYSTEMD_PSI_CGROUP_ROOT) + "/unified";
+    if (access(SYSTEMD_PSI_CGROUP_ROOT "/cgroup.controllers", F_OK) != 0 &&
+        access((hybrid + "/cgroup.controllers").c_str(), F_OK) == 0) {
+        cgroupRoot = hybrid;
+    }
+    if (pipe2(wakePipe, O_NONBLOCK | O_CLOEXEC) != 0) {
+        errlogPrintf("systemdPsi: pipe2 failed: %s\n", strerror(errno));
+        return;
+    }
+    epicsThreadCreate("systemdPsi", epicsThreadPriorityHigh,
+                      epicsThreadGetStackSize(epicsThreadStackMedium),
+                      psi_thread, nullptr);
+    epicsThreadCreate("systemdPsiCgroup", epicsThreadPriorityLow,
+                      epicsThreadGetStackSize(epicsThreadStackMedium),
+                      cgroup_thread, nullptr);
+}
+
+systemdPsiUnit* systemdPsiFind(const char* unit) {
+    epicsThreadOnce(&psiOnce, psi_once, nullptr);
+
+    epicsMutexLock(psiLock);
+    std::map<std::string, systemdPsiUnit*>::iterator it = psiUnits.find(unit);
+    systemdPsiUnit* u;
+    if (it != psiUnits.end()) {
+        u = it->second;
+    } else {
+        u = new systemdPsiUnit();
+        u->name = unit;
+        u->resolve = true;
+        u->resolveNow = true;
+        for (int r = 0; r < SYSTEMD_PSI_RESOURCES; r++) {
+            PsiTrigger* t = &u->trigger[r];
+            scanIoInit(&t->scan);
+            t->stallMs = 0;
+            t->fd = -1;
+            t->rearm = false;
+            t->lastError = 0;
+            t->stalled = false;
+            t->lastEvent = 0;
+        }
+        psiUnits[unit] = u;
+    }
+    epicsMutexUnlock(psiLock);
+    resolve_wake();
+    return u;
+}
+
+int systemdPsiResource(const char* name) {
+    for (int r = 0; r < SYSTEMD_PSI_RESOURCES; r++) {
+        if (strcmp(name, resourceNames[r]) == 0) {
+            return r;
+        }
+    }
+    return -1;
+}
+
+int systemdPsiRead(systemdPsiUnit* unit, int resource, bool full, int avg, double* value) {
+    epicsMutexLock(psiLock);
+    std::string dir = unit->cgroupDir;
+    epicsMutexUnlock(psiLock);
+    if (dir.empty()) {
+        return -ENOENT;
+    }
+
+    std::string path = dir + "/" + resourceNames[resource] + ".pressure";
+    FILE* f = fopen(path.c_str(), "re");
+    if (!f) {
+        int err = errno;
+        if (err == ENOENT) {
+            // Cgroup removed, let the cgroup thread look it up again
+            epicsMutexLock(psiLock);
+            unit->resolve = true;
+            epicsMutexUnlock(psiLock);
+            resolve_wake();
+        }
+        return -err;
+    }
+
+    // Lines look like: some avg10=0.12 avg60=0.05 avg300=0.01 total=12345
+    char line[256];
+    int ret = -ENODATA;
+    while (fgets(line, sizeof(line), f)) {
+        char kind[8];
+        double avg10, avg60, avg300;
+        if (sscanf(line, "%7s avg10=%lf avg60=%lf avg300=%lf",
+                   kind, &avg10, &avg60, &avg300) != 4) {
+            continue;
+        }
+        if (strcmp(kind, full ? "full" : "some") != 0) {
+            continue;
+        }
+        *value = avg == 10 ? avg10 : avg == 60 ? avg60 : avg300;
+        ret = 0;
+        break;
+    }
+    fclose(f);
+    return ret;
+}
+
+void systemdPsiSetTrigger(systemdPsiUnit* unit, int resource, double stall_ms) {
+    epicsMutexLock(psiLock);
+    PsiTrigger* t = &unit->trigger[resource];
+    t->stallMs = stall_ms > 0 ? stall_ms : 0;
+    t->rearm = true;
+    t->lastError = 0;
+    epicsMutexUnlock(psiLock);
+    psi_wake();
+}
+
+IOSCANPVT systemdPsiScan(systemdPsiUnit* unit, int resource) {
+    return unit->trigger[resource].scan;
+}
+
+bool systemdPsiUnarmed(systemdPsiUnit* unit, int resource) {
+    epicsMutexLock(psiLock);
+    bool unarmed = unit->trigger[resource].stallMs > 0 && unit->trigger[resource].fd < 0;
+    epicsMutexUnlock(psiLock);
+    return unarmed;
+}
+
+bool systemdPsiStalled(systemdPsiUnit* unit, int resource) {
+    epicsMutexLock(psiLock);
+    bool stalled = unit->trigger[resource].stalled;
+    epicsMutexUnlock(psiLock);
+    return stalled;
+}
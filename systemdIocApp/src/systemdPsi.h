@@ -0,0 +1,57 @@
+/* systemdPsi.h */
+/* Pressure Stall Information for the cgroup of each unit.
+ *
+ * Averages are read on demand from <cgroup>/{cpu,memory,io}.pressure.
+ * Stall alarms use kernel PSI triggers: writing "some <stall> <window>" to
+ * a pressure file arms a trigger, and a single monitor thread waits on all
+ * trigger fds with poll(). Each event processes the unit's I/O Intr records
+ * for that resource; the stall flag clears once events stop.
+ *
+ * The unit's cgroup path comes from its ControlGroup property and is
+ * looked up again whenever the cgroup goes away (e.g. the unit stopped).
+ * Lookups run on a second thread, so a slow systemd never holds up the
+ * monitor thread's poll() loop.
+ */
+
+#ifndef SYSTEMD_PSI_H
+#define SYSTEMD_PSI_H
+
+#include <dbScan.h>
+
+/* cgroup v2 mount; hybrid hierarchies mount it under unified/ instead */
+#define SYSTEMD_PSI_CGROUP_ROOT  "/sys/fs/cgroup"
+/* Trigger window. Unprivileged triggers need a multiple of 2 s. */
+#define SYSTEMD_PSI_WINDOW_US    2000000
+
+enum {
+    SYSTEMD_PSI_CPU = 0,
+    SYSTEMD_PSI_MEMORY,
+    SYSTEMD_PSI_IO,
+    SYSTEMD_PSI_RESOURCES
+};
+
+struct systemdPsiUnit;
+
+/* Look up a unit, creating it on first use. Never returns NULL. */
+systemdPsiUnit* systemdPsiFind(const char* unit);
+
+/* Resource index for "cpu", "memory" or "io", -1 otherwise. */
+int systemdPsiResource(const char* name);
+
+/* Read one average in percent. full selects the "full" line instead of
+ * "some", avg is 10, 60 or 300. Returns 0 or a negative errno. */
+int systemdPsiRead(systemdPsiUnit* unit, int resource, bool full, int avg, double* value);
+
+/* Set the stall threshold in ms per trigger window; 0 disarms the trigger. */
+void systemdPsiSetTrigger(systemdPsiUnit* unit, int resource, double stall_ms);
+
+IOSCANPVT systemdPsiScan(systemdPsiUnit* unit, int resource);
+
+/* True while a threshold is set but the trigger could not be registered,
+ * e.g. no cgroup or no write access to the pressure file. */
+bool systemdPsiUnarmed(systemdPsiUnit* unit, int resource);
+
+/* True while the resource's trigger fired within the last window. */
+bool systemdPsiStalled(systemdPsiUnit* unit, int resource);
+
+#endif /* SYSTEMD_PSI_H */
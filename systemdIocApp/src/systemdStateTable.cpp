@@ -0,0 +1,241 @@
+#include <epicsExport.h>
+#include <epicsMutex.h>
+#include <epicsExit.h>
+#include <epicsThread.h>
+#include <errlog.h>
+#include <iocsh.h>
+#include <string>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "systemdStateTable.h"
+
+static_assert(sizeof(systemdStateTableHeader) == 64, "state table header layout changed");
+static_assert(sizeof(systemdStateRecord) == 384, "state table record layout changed");
+
+// Writer side of the shared state table. One table per IOC, created by
+// systemdStateTableConfig() in st.cmd before iocInit.
+static epicsMutexId tableLock = nullptr;
+static systemdStateTableHeader* table = nullptr;
+static bool tableFullLogged = false;
+static bool heartbeatStarted = false;
+
+static void copy_field(char* dst, const char* src, size_t len) {
+    strncpy(dst, src ? src : "", len - 1);
+    dst[len - 1] = '\0';
+}
+
+static void state_table_exit(void*) {
+    epicsMutexLock(tableLock);
+    if (table) {
+        __atomic_fetch_or(&table->flags, SYSTEMD_STATE_TABLE_CLOSED, __ATOMIC_RELEASE);
+        munmap(table, SYSTEMD_STATE_TABLE_SIZE(table->capacity));
+        table = nullptr;
+    }
+    epicsMutexUnlock(tableLock);
+}
+
+static uint64_t monotonic_ns() {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+}
+
+static void heartbeat_thread(void*) {
+    while (true) {
+        epicsMutexLock(tableLock);
+        if (table) {
+            __atomic_store_n(&table->heartbeat_ns, monotonic_ns(), __ATOMIC_RELEASE);
+        }
+        epicsMutexUnlock(tableLock);
+        epicsThreadSleep(SYSTEMD_STATE_HEARTBEAT_NS / 1e9);
+    }
+}
+
+// Mark a table left at path by a previous IOC as closed. An IOC that crashed
+// or was killed never ran its exit handler, and readers still mapping that
+// file would otherwise keep trusting it after the rename below.
+static void close_stale_table(const char* path) {
+    int fd = open(path, O_RDWR | O_NOFOLLOW | O_CLOEXEC);
+    if (fd < 0) {
+        return;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode) || st.st_uid != geteuid() ||
+        (size_t)st.st_size < sizeof(systemdStateTableHeader)) {
+        close(fd);
+        return;
+    }
+    void* addr = mmap(nullptr, sizeof(systemdStateTableHeader), PROT_READ | PROT_WRITE,
+                      MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        return;
+    }
+    systemdStateTableHeader* hdr = (systemdStateTableHeader*)addr;
+    if (__atomic_load_n(&hdr->magic, __ATOMIC_ACQUIRE) == SYSTEMD_STATE_TABLE_MAGIC) {
+        __atomic_fetch_or(&hdr->flags, SYSTEMD_STATE_TABLE_CLOSED, __ATOMIC_RELEASE);
+    }
+    munmap(addr, sizeof(systemdStateTableHeader));
+}
+
+static int state_table_create(const char* path) {
+    // Build the table in a temporary file and rename it into place so that
+    // readers never map a half-initialised file. Readers still holding the
+    // previous file see SYSTEMD_STATE_TABLE_CLOSED and reopen the path.
+    // mkostemp() creates the file with O_EXCL, so a symlink planted in a
+    // world-writable directory such as /dev/shm is never followed.
+    std::string tmp = std::string(path) + ".XXXXXX";
+    size_t size = SYSTEMD_STATE_TABLE_SIZE(SYSTEMD_STATE_TABLE_CAPACITY);
+
+    int fd = mkostemp(&tmp[0], O_CLOEXEC);
+    if (fd < 0) {
+        return -errno;
+    }
+    if (fchmod(fd, 0644) != 0 || ftruncate(fd, size) != 0) {
+        int err = errno;
+        close(fd);
+        unlink(tmp.c_str());
+        return -err;
+    }
+    void* addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED) {
+        int err = errno;
+        unlink(tmp.c_str());
+        return -err;
+    }
+
+    systemdStateTableHeader* hdr = (systemdStateTableHeader*)addr;
+    hdr->version = SYSTEMD_STATE_TABLE_VERSION;
+    hdr->header_size = sizeof(systemdStateTableHeader);
+    hdr->record_size = sizeof(systemdStateRecord);
+    hdr->capacity = SYSTEMD_STATE_TABLE_CAPACITY;
+    hdr->count = 0;
+    hdr->flags = 0;
+    hdr->ioc_pid = (uint32_t)getpid();
+    hdr->generation = 0;
+    hdr->heartbeat_ns = monotonic_ns();
+    __atomic_store_n(&hdr->magic, SYSTEMD_STATE_TABLE_MAGIC, __ATOMIC_RELEASE);
+
+    close_stale_table(path);
+    if (rename(tmp.c_str(), path) != 0) {
+        int err = errno;
+        munmap(addr, size);
+        unlink(tmp.c_str());
+        return -err;
+    }
+
+    epicsMutexLock(tableLock);
+    systemdStateTableHeader* old = table;
+    table = hdr;
+    tableFullLogged = false;
+    if (!heartbeatStarted) {
+        epicsThreadCreate("systemdStateTable", epicsThreadPriorityLow,
+                          epicsThreadGetStackSize(epicsThreadStackSmall),
+                          heartbeat_thread, nullptr);
+        heartbeatStarted = true;
+    }
+    epicsMutexUnlock(tableLock);
+
+    if (old) {
+        __atomic_fetch_or(&old->flags, SYSTEMD_STATE_TABLE_CLOSED, __ATOMIC_RELEASE);
+        munmap(old, SYSTEMD_STATE_TABLE_SIZE(old->capacity));
+    } else {
+        epicsAtExit(state_table_exit, nullptr);
+    }
+    return 0;
+}
+
+void systemdStateTablePublish(const char* unit, const char* active_state,
+                              const char* status) {
+    if (!tableLock || !unit) {
+        return;
+    }
+
+    epicsMutexLock(tableLock);
+    if (!table) {
+        epicsMutexUnlock(tableLock);
+        return;
+    }
+
+    systemdStateRecord* records = systemdStateTableRecords(table);
+    uint32_t count = table->count;
+    uint32_t idx;
+    for (idx = 0; idx < count; idx++) {
+        if (strncmp(records[idx].unit, unit, SYSTEMD_STATE_UNIT_LEN) == 0) {
+            break;
+        }
+    }
+    if (idx == count) {
+        if (count >= table->capacity) {
+            if (!tableFullLogged) {
+                errlogPrintf("systemdStateTable: table full (%u units), %s not published\n",
+                             table->capacity, unit);
+                tableFullLogged = true;
+            }
+            epicsMutexUnlock(tableLock);
+            return;
+        }
+        // New slot: fill in the unit name before publishing the new count
+        copy_field(records[idx].unit, unit, sizeof(records[idx].unit));
+        __atomic_store_n(&table->count, count + 1, __ATOMIC_RELEASE);
+    }
+
+    systemdStateRecord* rec = &records[idx];
+    bool changed = strncmp(rec->active_state, active_state ? active_state : "",
+                           sizeof(rec->active_state)) != 0 ||
+                   strncmp(rec->status, status ? status : "",
+                           sizeof(rec->status)) != 0;
+
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+
+    // Seqlock write: odd sequence number while the slot is being modified
+    uint32_t seq = rec->seq;
+    __atomic_store_n(&rec->seq, seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    copy_field(rec->active_state, active_state, sizeof(rec->active_state));
+    copy_field(rec->status, status, sizeof(rec->status));
+    rec->update_count++;
+    rec->updated_ns = (uint64_t)now.tv_sec * 1000000000ull + (uint64_t)now.tv_nsec;
+    __atomic_store_n(&rec->seq, seq + 2, __ATOMIC_RELEASE);
+
+    if (changed) {
+        __atomic_fetch_add(&table->generation, 1, __ATOMIC_RELEASE);
+    }
+    epicsMutexUnlock(tableLock);
+}
+
+// iocsh: systemdStateTableConfig("/dev/shm/systemdIoc.state")
+static const iocshArg stateTableConfigArg0 = {"path", iocshArgString};
+static const iocshArg* const stateTableConfigArgs[] = {&stateTableConfigArg0};
+static const iocshFuncDef stateTableConfigFuncDef = {"systemdStateTableConfig", 1, stateTableConfigArgs};
+
+static void stateTableConfigCallFunc(const iocshArgBuf* args) {
+    const char* path = args[0].sval;
+    if (!path || strlen(path) == 0) {
+        path = SYSTEMD_STATE_TABLE_DEFAULT;
+    }
+    int ret = state_table_create(path);
+    if (ret < 0) {
+        errlogPrintf("systemdStateTableConfig: cannot create %s: %s\n", path, strerror(-ret));
+    }
+}
+
+static void systemdStateTableRegister(void) {
+    if (!tableLock) {
+        tableLock = epicsMutexMustCreate();
+    }
+    iocshRegister(&stateTableConfigFuncDef, stateTableConfigCallFunc);
+}
+
+extern "C" {
+epicsExportRegistrar(systemdStateTableRegister);
+}
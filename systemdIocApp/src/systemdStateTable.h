@@ -0,0 +1,78 @@
+/* systemdStateTable.h */
+/* Fixed layout of the memory-mapped unit state table published by the IOC.
+ *
+ * The file starts with a systemdStateTableHeader followed by `capacity`
+ * systemdStateRecord slots.  Each slot is protected by its own seqlock:
+ * the writer makes `seq` odd, updates the slot and makes `seq` even again.
+ * Readers copy a slot and retry if `seq` was odd or changed during the copy.
+ *
+ * The IOC sets SYSTEMD_STATE_TABLE_CLOSED when it exits and, on startup, on
+ * any table left behind at the same path. An IOC that is still hung or was
+ * killed can only be detected by `heartbeat_ns` no longer advancing.
+ *
+ * This header is shared by the IOC (writer) and the C reader library in
+ * servalStandAlone/stateReader, so it must stay plain C.
+ */
+
+#ifndef SYSTEMD_STATE_TABLE_H
+#define SYSTEMD_STATE_TABLE_H
+
+#include <stdint.h>
+
+#define SYSTEMD_STATE_TABLE_MAGIC      0x54534453u  /* "SDST" */
+#define SYSTEMD_STATE_TABLE_VERSION    1u
+#define SYSTEMD_STATE_TABLE_CAPACITY   256u
+#define SYSTEMD_STATE_TABLE_DEFAULT    "/dev/shm/systemdIoc.state"
+/* heartbeat_ns refresh period; treat the table as dead after a few misses */
+#define SYSTEMD_STATE_HEARTBEAT_NS     1000000000ull
+
+#define SYSTEMD_STATE_UNIT_LEN         256
+#define SYSTEMD_STATE_ACTIVE_LEN       32
+#define SYSTEMD_STATE_STATUS_LEN       40
+
+/* Header flags */
+#define SYSTEMD_STATE_TABLE_CLOSED     0x1u  /* IOC exited or was replaced, reopen the path */
+
+typedef struct {
+    uint32_t magic;            /* written last, readers must check it first */
+    uint32_t version;
+    uint32_t header_size;
+    uint32_t record_size;
+    uint32_t capacity;
+    uint32_t count;            /* slots in use, only ever grows */
+    uint32_t flags;
+    uint32_t ioc_pid;
+    uint64_t generation;       /* bumped whenever a unit changes state */
+    uint64_t heartbeat_ns;     /* CLOCK_MONOTONIC, refreshed while the IOC runs */
+    uint8_t  reserved[16];
+} systemdStateTableHeader;
+
+typedef struct {
+    uint32_t seq;              /* seqlock, odd while the writer is active */
+    uint32_t reserved0;
+    uint64_t update_count;
+    uint64_t updated_ns;       /* CLOCK_REALTIME of the last update */
+    char     unit[SYSTEMD_STATE_UNIT_LEN];
+    char     active_state[SYSTEMD_STATE_ACTIVE_LEN];  /* raw ActiveState */
+    char     status[SYSTEMD_STATE_STATUS_LEN];        /* Status PV value */
+    uint8_t  reserved1[32];
+} systemdStateRecord;
+
+#define SYSTEMD_STATE_TABLE_SIZE(capacity) \
+    (sizeof(systemdStateTableHeader) + (size_t)(capacity) * sizeof(systemdStateRecord))
+
+static inline systemdStateRecord *
+systemdStateTableRecords(systemdStateTableHeader *hdr)
+{
+    return (systemdStateRecord *)((char *)hdr + sizeof(systemdStateTableHeader));
+}
+
+#ifdef __cplusplus
+/* IOC-side writer, implemented in systemdStateTable.cpp.
+ * Publishing is a no-op until systemdStateTableConfig has been called.
+ */
+void systemdStateTablePublish(const char *unit, const char *active_state,
+                              const char *status);
+#endif
+
+#endif /* SYSTEMD_STATE_TABLE_H */